@@ -8,22 +8,42 @@
 #include <cstdlib>
 #include <cstring>
 #include <cstdint>
+#include <cerrno>
 #include <vector>
 #include <mutex>
 #include <climits>
 #include <thread>
+#include <deque>
+#include <chrono>
+#include <utility>
+#include <string>
 #include <zlib.h>
 
+#ifdef __linux__
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#endif
+
 static void exit_usage(const char **argv);
 static int compress_file(const char *input_file, const char *output_file);
+static int compress_file_follow(const char *input_file, const char *output_file);
 static int decompress_file(const char *input_file, const char *output_file);
-static std::vector<std::byte> read_file(const char *input, std::size_t minimum_size);
+static std::vector<std::byte> read_file(const char *input, std::size_t minimum_size, std::vector<std::pair<std::size_t, std::size_t>> *data_extents = nullptr);
 
 #define NOTE "(')> "
 #define SUCCESS "(^)< "
 #define ERROR "(X)> "
 
 int main(int argc, const char **argv) {
+    // Compress a file that is still being written?
+    if(argc == 5 && std::strcmp(argv[1], "c") == 0 && std::strcmp(argv[2], "--follow") == 0) {
+        return compress_file_follow(argv[3], argv[4]);
+    }
+
     // Make sure we have enough arguments!
     if(argc != 4) {
         exit_usage(argv);
@@ -63,7 +83,11 @@ struct Worker {
 static void perform_decompression(Worker *worker);
 static void perform_compression(Worker *worker);
 static void perform_job(std::vector<Worker> &workers, void (*function)(Worker *));
-static int write_file(const char *output_file, const std::vector<Worker> &workers, const std::vector<std::byte> &start = std::vector<std::byte>());
+template<typename Workers> static std::size_t busy_workers(Workers &workers);
+template<typename Workers> static Worker *next_worker(Workers &workers);
+static void setup_compression_worker(Worker &worker, const std::byte *input, std::size_t input_size);
+template<typename Workers> static int finish_compression(const char *output_file, const Workers &workers);
+template<typename Workers> static int write_file(const char *output_file, const Workers &workers, const std::vector<std::byte> &start = std::vector<std::byte>());
 
 static int decompress_file(const char *input_file, const char *output_file) {
     // Read the file
@@ -142,22 +166,36 @@ static_assert(sizeof(CacheFileHeader) == 0x800);
 
 static int compress_file(const char *input_file, const char *output_file) {
     // Read the file
-    auto uncompressed_file = read_file(input_file, 0);
+    std::vector<std::pair<std::size_t, std::size_t>> data_extents;
+    auto uncompressed_file = read_file(input_file, 0, &data_extents);
     auto file_size = uncompressed_file.size();
     std::size_t block_count = file_size / CHUNK_SIZE + ((file_size % CHUNK_SIZE) > 0);
 
-    // Make a header
-    std::vector<std::byte> header(sizeof(CompressedMapHeader));
-    CompressedMapHeader &header_v = *reinterpret_cast<CompressedMapHeader *>(header.data());
+    // Make sure it fits
     if(block_count > CompressedMapHeader::MAX_BLOCKS) {
         std::fprintf(stderr, ERROR "Maximum blocks exceeded (#%zu > %zu)\n", block_count, CompressedMapHeader::MAX_BLOCKS);
         return EXIT_FAILURE;
     }
-    header_v.block_count = static_cast<std::uint32_t>(block_count);
     std::printf(NOTE "Compressing %zu chunk%s...\n", block_count, block_count == 1 ? "" : "s");
 
+    // Compress a chunk of zeroes once so chunks that lie entirely within holes can just copy it
+    Worker zero_worker;
+    std::vector<std::byte> zero_chunk;
+    if(block_count > 0 && (data_extents.size() != 1 || data_extents[0].first != 0 || data_extents[0].second != file_size)) {
+        zero_chunk.resize(CHUNK_SIZE);
+        setup_compression_worker(zero_worker, zero_chunk.data(), zero_chunk.size());
+        zero_worker.mutex.lock();
+        perform_compression(&zero_worker);
+        if(zero_worker.failure) {
+            std::fprintf(stderr, ERROR "Failed to compress an empty chunk\n");
+            return EXIT_FAILURE;
+        }
+    }
+
     // Allocate workers
     std::vector<Worker> workers(block_count);
+    auto extent = data_extents.begin();
+    std::size_t hole_count = 0;
     for(std::size_t i = 0; i < block_count; i++) {
         std::size_t offset = i * CHUNK_SIZE;
         if(offset + sizeof(std::uint32_t) > file_size) {
@@ -165,27 +203,53 @@ static int compress_file(const char *input_file, const char *output_file) {
             return EXIT_FAILURE;
         }
 
-        // Set up the worker
-        auto *input = uncompressed_file.data() + offset;
         std::size_t remaining_size = file_size - offset;
         if(remaining_size > CHUNK_SIZE) {
             remaining_size = CHUNK_SIZE;
         }
-        workers[i].offset = sizeof(std::uint32_t);
-        std::size_t max_size = remaining_size * 2 + workers[i].offset;
 
-        workers[i].input = input;
-        workers[i].input_size = remaining_size;
-        workers[i].output = std::make_unique<std::byte []>(max_size);
-        workers[i].output_size = max_size;
+        // If no data lies in this chunk, use the empty chunk instead
+        while(extent != data_extents.end() && extent->second <= offset) {
+            extent++;
+        }
+        if(!zero_chunk.empty() && remaining_size == CHUNK_SIZE && (extent == data_extents.end() || extent->first >= offset + remaining_size)) {
+            workers[i].output = std::make_unique<std::byte []>(zero_worker.output_size);
+            workers[i].output_size = zero_worker.output_size;
+            std::memcpy(workers[i].output.get(), zero_worker.output.get(), zero_worker.output_size);
+            workers[i].started = true;
+            hole_count++;
+        }
 
-        *reinterpret_cast<std::uint32_t *>(workers[i].output.get()) = static_cast<std::uint32_t>(remaining_size);
+        // Otherwise, set up the worker
+        else {
+            setup_compression_worker(workers[i], uncompressed_file.data() + offset, remaining_size);
+        }
+    }
+    if(hole_count > 0) {
+        std::printf(NOTE "Skipped %zu empty chunk%s\n", hole_count, hole_count == 1 ? "" : "s");
     }
 
     // Do it!
     perform_job(workers, perform_compression);
 
+    return finish_compression(output_file, workers);
+}
+
+static void setup_compression_worker(Worker &worker, const std::byte *input, std::size_t input_size) {
+    worker.offset = sizeof(std::uint32_t);
+    std::size_t max_size = input_size * 2 + worker.offset;
+
+    worker.input = input;
+    worker.input_size = input_size;
+    worker.output = std::make_unique<std::byte []>(max_size);
+    worker.output_size = max_size;
+
+    *reinterpret_cast<std::uint32_t *>(worker.output.get()) = static_cast<std::uint32_t>(input_size);
+}
+
+template<typename Workers> static int finish_compression(const char *output_file, const Workers &workers) {
     // If we failed, error out
+    std::size_t block_count = workers.size();
     bool failed = false;
     for(std::size_t i = 0; i < block_count; i++) {
         if(workers[i].failure) {
@@ -197,6 +261,11 @@ static int compress_file(const char *input_file, const char *output_file) {
         return EXIT_FAILURE;
     }
 
+    // Make a header
+    std::vector<std::byte> header(sizeof(CompressedMapHeader));
+    CompressedMapHeader &header_v = *reinterpret_cast<CompressedMapHeader *>(header.data());
+    header_v.block_count = static_cast<std::uint32_t>(block_count);
+
     // Set the offsets
     std::size_t current_offset = header.size();
     for(std::size_t i = 0; i < block_count; i++) {
@@ -211,6 +280,335 @@ static int compress_file(const char *input_file, const char *output_file) {
     return write_file(output_file, workers, header);
 }
 
+#ifdef __linux__
+static bool read_block(int fd, std::byte *data, std::size_t size, std::size_t offset) {
+    while(size > 0) {
+        auto r = pread(fd, data, size, static_cast<off_t>(offset));
+        if(r <= 0) {
+            return false;
+        }
+        data += r;
+        size -= static_cast<std::size_t>(r);
+        offset += static_cast<std::size_t>(r);
+    }
+    return true;
+}
+static bool open_for_writing(int fd) {
+    struct stat target;
+    if(fstat(fd, &target) != 0) {
+        return false;
+    }
+
+    // Look through every other process's open files for this one
+    auto *proc = opendir("/proc");
+    if(!proc) {
+        return false;
+    }
+    auto self = std::to_string(getpid());
+    bool found = false;
+    while(auto *process = readdir(proc)) {
+        if(process->d_name[0] < '0' || process->d_name[0] > '9' || self == process->d_name) {
+            continue;
+        }
+        auto fd_path = std::string("/proc/") + process->d_name + "/fd";
+        auto *fds = opendir(fd_path.c_str());
+        if(!fds) {
+            continue;
+        }
+        while(auto *entry = readdir(fds)) {
+            struct stat st;
+            if(entry->d_name[0] == '.' || stat((fd_path + "/" + entry->d_name).c_str(), &st) != 0 || st.st_dev != target.st_dev || st.st_ino != target.st_ino) {
+                continue;
+            }
+
+            // It's the file, but is it open for writing?
+            auto info_path = std::string("/proc/") + process->d_name + "/fdinfo/" + entry->d_name;
+            auto *info = std::fopen(info_path.c_str(), "r");
+            if(!info) {
+                continue;
+            }
+            char line[256];
+            while(std::fgets(line, sizeof(line), info)) {
+                unsigned int flags;
+                if(std::sscanf(line, "flags: %o", &flags) == 1) {
+                    found = (flags & O_ACCMODE) != O_RDONLY;
+                    break;
+                }
+            }
+            std::fclose(info);
+            if(found) {
+                break;
+            }
+        }
+        closedir(fds);
+        if(found) {
+            break;
+        }
+    }
+    closedir(proc);
+    return found;
+}
+#endif
+
+#define FOLLOW_QUIET_TIME std::chrono::milliseconds(500)
+#define FOLLOW_IDLE_TIME std::chrono::seconds(5)
+
+static int compress_file_follow(const char *input_file, const char *output_file) {
+    #ifndef __linux__
+    std::fprintf(stderr, ERROR "--follow is only supported on Linux\n");
+    return EXIT_FAILURE;
+    #else
+    // Watch the directory so we know if the file is created or replaced
+    std::string input_path = input_file;
+    auto slash = input_path.rfind('/');
+    std::string directory = slash == std::string::npos ? "." : slash == 0 ? "/" : input_path.substr(0, slash);
+    std::string name = slash == std::string::npos ? input_path : input_path.substr(slash + 1);
+    int inotify_fd = inotify_init1(IN_CLOEXEC);
+    if(inotify_fd < 0 || inotify_add_watch(inotify_fd, directory.c_str(), IN_CREATE | IN_MOVED_TO) < 0) {
+        std::fprintf(stderr, ERROR "Failed to watch %s for changes\n", directory.c_str());
+        if(inotify_fd >= 0) {
+            close(inotify_fd);
+        }
+        return EXIT_FAILURE;
+    }
+
+    // Deques don't move their elements when they grow, so the workers' mutexes and input pointers stay put
+    std::deque<Worker> workers;
+    std::deque<std::vector<std::byte>> blocks;
+    std::size_t max_threads = std::thread::hardware_concurrency();
+    std::size_t file_size = 0;
+    int fd = -1;
+    int file_watch = -1;
+    bool closed = false;
+    int result = EXIT_SUCCESS;
+
+    auto fail = [&](const char *message) {
+        std::fprintf(stderr, ERROR "%s\n", message);
+        result = EXIT_FAILURE;
+    };
+
+    // Start whatever workers we can without blocking
+    auto start_workers = [&]() {
+        while(auto *next = next_worker(workers)) {
+            if(max_threads <= 1) {
+                next->started = true;
+                perform_compression(next);
+            }
+            else if(busy_workers(workers) < max_threads) {
+                next->started = true;
+                std::thread(perform_compression, next).detach();
+            }
+            else {
+                break;
+            }
+        }
+    };
+
+    // Throw away every worker past keep, waiting for any that are still running. Workers that never started still hold
+    // their locks, so let those go, too, since destroying a locked mutex is undefined.
+    auto discard_workers = [&](std::size_t keep) {
+        while(busy_workers(workers) > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        for(std::size_t i = keep; i < workers.size(); i++) {
+            if(!workers[i].started) {
+                workers[i].mutex.unlock();
+            }
+        }
+        workers.resize(keep);
+        blocks.resize(keep);
+    };
+
+    // Read and queue every block that has been written. Until the writer is done, only whole blocks are taken.
+    auto queue_blocks = [&]() {
+        if(fd < 0) {
+            return;
+        }
+        struct stat st;
+        if(fstat(fd, &st) != 0) {
+            return fail("Failed to query the input file's size");
+        }
+        file_size = static_cast<std::size_t>(st.st_size);
+
+        // If the file was truncated (e.g. it was reopened with "wb"), whatever we have is stale
+        if(!blocks.empty() && file_size < (blocks.size() - 1) * CHUNK_SIZE + blocks.back().size()) {
+            std::printf(NOTE "%s was truncated; starting over...\n", input_file);
+            discard_workers(0);
+        }
+
+        // If the last block was partial and the file grew, take it again
+        else if(!blocks.empty() && blocks.back().size() < CHUNK_SIZE && file_size > (blocks.size() - 1) * CHUNK_SIZE + blocks.back().size()) {
+            discard_workers(blocks.size() - 1);
+        }
+
+        while(true) {
+            std::size_t offset = blocks.size() * CHUNK_SIZE;
+            if(offset >= file_size) {
+                break;
+            }
+            std::size_t remaining_size = file_size - offset;
+            if(remaining_size < CHUNK_SIZE && !closed) {
+                break;
+            }
+            if(remaining_size > CHUNK_SIZE) {
+                remaining_size = CHUNK_SIZE;
+            }
+            if(blocks.size() == CompressedMapHeader::MAX_BLOCKS) {
+                char message[64];
+                std::snprintf(message, sizeof(message), "Maximum blocks exceeded (#%zu > %zu)", blocks.size() + 1, CompressedMapHeader::MAX_BLOCKS);
+                return fail(message);
+            }
+
+            auto &block = blocks.emplace_back(remaining_size);
+            if(!read_block(fd, block.data(), remaining_size, offset)) {
+                blocks.pop_back();
+                return fail("An error occurred when reading the input file");
+            }
+            auto &worker = workers.emplace_back();
+            setup_compression_worker(worker, block.data(), remaining_size);
+            worker.mutex.lock();
+        }
+    };
+
+    // (Re)open the file and start over with it
+    auto open_input = [&]() {
+        discard_workers(0);
+        if(file_watch >= 0) {
+            inotify_rm_watch(inotify_fd, file_watch);
+            file_watch = -1;
+        }
+        if(fd >= 0) {
+            close(fd);
+        }
+        fd = open(input_file, O_RDONLY | O_CLOEXEC);
+        if(fd < 0) {
+            return;
+        }
+        file_watch = inotify_add_watch(inotify_fd, input_file, IN_OPEN | IN_MODIFY | IN_CLOSE_WRITE);
+        if(file_watch < 0) {
+            return fail("Failed to watch the input file for changes");
+        }
+        queue_blocks();
+    };
+
+    open_input();
+    if(fd < 0) {
+        std::printf(NOTE "Waiting for %s to be created...\n", input_file);
+    }
+    std::printf(NOTE "Following %s; waiting for the writer to close it...\n", input_file);
+    std::fflush(stdout);
+
+    // Compress as we go until nothing has touched the file for a bit and nothing has it open for writing. Once a writer
+    // has closed it, only wait long enough to catch it being reopened (e.g. to patch the header). Otherwise, give the
+    // writer time to start.
+    using clock = std::chrono::steady_clock;
+    auto last_activity = clock::now();
+    bool close_seen = false;
+    while(!closed && result == EXIT_SUCCESS) {
+        pollfd pfd = { inotify_fd, POLLIN, 0 };
+        bool written = false;
+        bool recreated = false;
+        if(poll(&pfd, 1, next_worker(workers) ? 20 : 250) > 0) {
+            alignas(inotify_event) char events[4096];
+            auto length = read(inotify_fd, events, sizeof(events));
+            for(ssize_t i = 0; i < length; ) {
+                const auto *event = reinterpret_cast<const inotify_event *>(events + i);
+                if(event->wd == file_watch) {
+                    written = written || (event->mask & (IN_MODIFY | IN_CLOSE_WRITE));
+                    close_seen = (close_seen || (event->mask & IN_CLOSE_WRITE)) && !(event->mask & (IN_OPEN | IN_MODIFY));
+                    last_activity = clock::now();
+                }
+                else if(event->len > 0 && name == event->name) {
+                    recreated = true;
+                    last_activity = clock::now();
+                }
+                i += sizeof(inotify_event) + event->len;
+            }
+        }
+
+        if(recreated) {
+            if(fd >= 0) {
+                std::printf(NOTE "%s was replaced; starting over...\n", input_file);
+            }
+            open_input();
+        }
+        else if(written) {
+            queue_blocks();
+        }
+        start_workers();
+
+        auto quiet = clock::now() - last_activity;
+        if(fd >= 0 && quiet >= FOLLOW_QUIET_TIME && (close_seen || quiet >= FOLLOW_IDLE_TIME) && !next_worker(workers) && !open_for_writing(fd)) {
+            if(!close_seen) {
+                std::printf(NOTE "Nothing has %s open for writing; finishing...\n", input_file);
+            }
+            closed = true;
+            queue_blocks();
+        }
+    }
+
+    // Wait for everything in flight to finish, then make sure nothing we already read was rewritten afterward (e.g. the
+    // cache file header being filled in at the end). Anything that changed gets compressed again.
+    std::vector<std::byte> current(CHUNK_SIZE);
+    while(result == EXIT_SUCCESS) {
+        while(next_worker(workers) || busy_workers(workers) > 0) {
+            start_workers();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        // Pick up anything that changed the size since then
+        struct stat st;
+        if(fstat(fd, &st) != 0) {
+            fail("Failed to query the input file's size");
+            break;
+        }
+        bool resized = static_cast<std::size_t>(st.st_size) != file_size;
+        if(resized) {
+            queue_blocks();
+            if(result != EXIT_SUCCESS) {
+                break;
+            }
+        }
+
+        std::size_t changed = 0;
+        for(std::size_t i = 0; i < blocks.size() && result == EXIT_SUCCESS; i++) {
+            auto &block = blocks[i];
+            if(!read_block(fd, current.data(), block.size(), i * CHUNK_SIZE)) {
+                fail("An error occurred when reading the input file");
+            }
+            else if(std::memcmp(current.data(), block.data(), block.size()) != 0) {
+                std::memcpy(block.data(), current.data(), block.size());
+                setup_compression_worker(workers[i], block.data(), block.size());
+                workers[i].failure = false;
+                workers[i].started = false;
+                workers[i].mutex.lock();
+                changed++;
+            }
+        }
+        if(changed > 0) {
+            std::printf(NOTE "Recompressing %zu rewritten chunk%s...\n", changed, changed == 1 ? "" : "s");
+        }
+        else if(!resized) {
+            break;
+        }
+    }
+
+    close(inotify_fd);
+    if(fd >= 0) {
+        close(fd);
+    }
+
+    // Don't leave detached threads touching workers that are about to be destroyed
+    if(result != EXIT_SUCCESS) {
+        discard_workers(0);
+        return result;
+    }
+
+    std::printf(NOTE "Compressed %zu chunk%s\n", workers.size(), workers.size() == 1 ? "" : "s");
+    return finish_compression(output_file, workers);
+    #endif
+}
+
 static void perform_decompression(Worker *worker) {
     z_stream inflate_stream = {};
     inflate_stream.zalloc = Z_NULL;
@@ -246,10 +644,11 @@ static void perform_compression(Worker *worker) {
 
 static void exit_usage(const char **argv) {
     std::printf(NOTE "Usage: %s <c|d> <input> <output>\n", *argv);
+    std::printf(NOTE "       %s c --follow <input> <output>\n", *argv);
     std::exit(EXIT_FAILURE);
 }
 
-static std::vector<std::byte> read_file(const char *input, std::size_t minimum_size) {
+static std::vector<std::byte> read_file(const char *input, std::size_t minimum_size, std::vector<std::pair<std::size_t, std::size_t>> *data_extents) {
     #ifdef _WIN32
     #define TELL _ftelli64
     #define SEEK _fseeki64
@@ -280,22 +679,64 @@ static std::vector<std::byte> read_file(const char *input, std::size_t minimum_s
     std::fseek(file, 0, SEEK_END);
     std::size_t size = static_cast<std::size_t>(TELL(file));
     data.resize(size, std::byte());
-    SEEK(file, offset, SEEK_SET);
+    if(data_extents) {
+        data_extents->clear();
+        if(minimum_size) {
+            data_extents->emplace_back(0, minimum_size);
+        }
+    }
     while(offset < size) {
-        std::size_t remainder = size - offset;
-        if(std::fread(data.data() + offset, remainder > LONG_MAX ? LONG_MAX : static_cast<long>(remainder), 1, file) != 1) {
-            std::fprintf(stderr, ERROR "An error occurred when reading %s\n", input);
-            std::fclose(file);
-            std::exit(EXIT_FAILURE);
+        // Sparse files can have huge holes in them, and those are already zeroed in data, so only read where there's data
+        std::size_t data_start = offset;
+        std::size_t data_end = size;
+        #if defined(__linux__) && defined(SEEK_DATA)
+        int fd = fileno(file);
+        auto next_data = lseek(fd, static_cast<off_t>(offset), SEEK_DATA);
+        if(next_data < 0 && errno == ENXIO) {
+            break;
+        }
+        else if(next_data >= 0) {
+            data_start = static_cast<std::size_t>(next_data);
+            auto next_hole = lseek(fd, next_data, SEEK_HOLE);
+            if(next_hole >= 0 && static_cast<std::size_t>(next_hole) < size) {
+                data_end = static_cast<std::size_t>(next_hole);
+            }
         }
-        offset += remainder;
+        if(data_start >= data_end) {
+            break;
+        }
+        #endif
+
+        SEEK(file, data_start, SEEK_SET);
+        for(std::size_t read_offset = data_start; read_offset < data_end;) {
+            std::size_t remainder = data_end - read_offset;
+            if(remainder > LONG_MAX) {
+                remainder = LONG_MAX;
+            }
+            if(std::fread(data.data() + read_offset, remainder, 1, file) != 1) {
+                std::fprintf(stderr, ERROR "An error occurred when reading %s\n", input);
+                std::fclose(file);
+                std::exit(EXIT_FAILURE);
+            }
+            read_offset += remainder;
+        }
+
+        if(data_extents) {
+            if(!data_extents->empty() && data_extents->back().second == data_start) {
+                data_extents->back().second = data_end;
+            }
+            else {
+                data_extents->emplace_back(data_start, data_end);
+            }
+        }
+        offset = data_end;
     }
     std::fclose(file);
 
     return data;
 }
 
-static int write_file(const char *output_file, const std::vector<Worker> &workers, const std::vector<std::byte> &start) {
+template<typename Workers> static int write_file(const char *output_file, const Workers &workers, const std::vector<std::byte> &start) {
     std::FILE *f = std::fopen(output_file, "wb");
     if(!f) {
         std::fprintf(stderr, ERROR "Failed to open %s for writing\n", output_file);
@@ -324,24 +765,25 @@ static int write_file(const char *output_file, const std::vector<Worker> &worker
     return EXIT_SUCCESS;
 }
 
-static std::size_t busy_workers(std::vector<Worker> &workers);
-static Worker *next_worker(std::vector<Worker> &workers);
-
 static void perform_job(std::vector<Worker> &workers, void (*function)(Worker *)) {
     if(workers.size() == 0) {
         return;
     }
 
-    // Lock the mutex!
+    // Lock the mutex! Workers that are already marked as started were done ahead of time, so leave them be.
     for(auto &w : workers) {
-        w.mutex.lock();
+        if(!w.started) {
+            w.mutex.lock();
+        }
     }
 
     // If we aren't threaded, just do a for loop
     std::size_t max_threads = std::thread::hardware_concurrency();
     if(max_threads <= 1) {
         for(auto &worker : workers) {
-            function(&worker);
+            if(!worker.started) {
+                function(&worker);
+            }
         }
     }
 
@@ -364,7 +806,7 @@ static void perform_job(std::vector<Worker> &workers, void (*function)(Worker *)
     }
 }
 
-static std::size_t busy_workers(std::vector<Worker> &workers) {
+template<typename Workers> static std::size_t busy_workers(Workers &workers) {
     std::size_t count = 0;
     for(auto &w : workers) {
         if(w.mutex.try_lock()) {
@@ -377,7 +819,7 @@ static std::size_t busy_workers(std::vector<Worker> &workers) {
     return count;
 }
 
-static Worker *next_worker(std::vector<Worker> &workers) {
+template<typename Workers> static Worker *next_worker(Workers &workers) {
     for(auto &w : workers) {
         if(!w.started) {
             return &w;